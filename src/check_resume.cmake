@@ -0,0 +1,33 @@
+# Counts the solutions of PUZZLE in one run and again across several runs
+# split with --limit, --checkpoint and --resume; both totals must equal
+# EXPECTED.
+#
+# cmake -DSUDOKU=<binary> -DPUZZLE=<file> -DEXPECTED=<count> -DWORK_DIR=<dir>
+#       -P check_resume.cmake
+
+function(run_sudoku expected_status)
+    execute_process(COMMAND ${SUDOKU} ${ARGN}
+        RESULT_VARIABLE status
+        OUTPUT_QUIET
+        ERROR_VARIABLE output)
+    if (NOT status EQUAL ${expected_status})
+        message(FATAL_ERROR "'sudoku ${ARGN}' exited with ${status}, expected ${expected_status}:\n${output}")
+    endif()
+    string(REGEX MATCH "solutions: ([0-9]+)" match "${output}")
+    set(solutions ${CMAKE_MATCH_1} PARENT_SCOPE)
+endfunction()
+
+run_sudoku(0 --count ${PUZZLE})
+if (NOT solutions EQUAL ${EXPECTED})
+    message(FATAL_ERROR "single run found ${solutions} solutions, expected ${EXPECTED}")
+endif()
+
+set(CHECKPOINT ${WORK_DIR}/check_resume.ckpt)
+file(REMOVE ${CHECKPOINT})
+run_sudoku(2 --count --limit 10000 --checkpoint ${CHECKPOINT} 
+    --checkpoint-interval 50000 ${PUZZLE})
+run_sudoku(2 --count --limit 10000 --resume ${CHECKPOINT} --checkpoint-interval 50000)
+run_sudoku(0 --count --resume ${CHECKPOINT})
+if (NOT solutions EQUAL ${EXPECTED})
+    message(FATAL_ERROR "resumed runs found ${solutions} solutions, expected ${EXPECTED}")
+endif()
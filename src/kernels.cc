@@ -0,0 +1,225 @@
+// This file is part of SudokuSover, a simple implementation of search for
+// solving sudoku puzzles.
+// 
+// Copyright (C) 2011 Nathan Ratliff <ratliff.nathan@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the LGNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the LGNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "kernels.h"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////
+// Generic kernel bodies
+////////////////////////////////////////////////////////////////////
+
+// The bodies are always inlined into each variant below so that the
+// compiler generates code for that variant's instruction set.
+#define KERNEL_BODY static inline __attribute__((always_inline))
+
+namespace{
+
+struct CellUnits{
+    unsigned char row[81], col[81], set[81];
+    CellUnits(){
+        for (int c = 0; c < 81; ++c){
+            row[c] = c/9;
+            col[c] = c%9;
+            set[c] = (c/27)*3 + (c%9)/3;
+        }
+    }
+};
+const CellUnits units;
+
+KERNEL_BODY void compute_candidates_body(const int *cells, CandidateMask *masks){
+    unsigned rows[9] = {0}, cols[9] = {0}, sets[9] = {0};
+    for (int c = 0; c < 81; ++c){
+        if (cells[c] >= 0){
+            unsigned bit = 1u << cells[c];
+            rows[units.row[c]] |= bit;
+            cols[units.col[c]] |= bit;
+            sets[units.set[c]] |= bit;
+        }
+    }
+    for (int c = 0; c < 81; ++c){
+        unsigned used = rows[units.row[c]] | cols[units.col[c]] | sets[units.set[c]];
+        masks[c] = (cells[c] >= 0)?0:(~used & kAllCandidates);
+    }
+}
+
+KERNEL_BODY bool is_valid_body(const int *cells){
+    unsigned rows[9] = {0}, cols[9] = {0}, sets[9] = {0};
+    for (int c = 0; c < 81; ++c){
+        if (cells[c] >= 0){
+            unsigned bit = 1u << cells[c];
+            unsigned &row = rows[units.row[c]];
+            unsigned &col = cols[units.col[c]];
+            unsigned &set = sets[units.set[c]];
+            if ((row | col | set) & bit) return false;
+            row |= bit;
+            col |= bit;
+            set |= bit;
+        }
+    }
+    return true;
+}
+
+KERNEL_BODY bool is_consistent_body(const int *cells, const CandidateMask *masks){
+    unsigned rows[9] = {0}, cols[9] = {0}, sets[9] = {0};
+    for (int c = 0; c < 81; ++c){
+        unsigned bits = (cells[c] >= 0)?(1u << cells[c]):masks[c];
+        rows[units.row[c]] |= bits;
+        cols[units.col[c]] |= bits;
+        sets[units.set[c]] |= bits;
+    }
+    unsigned all = kAllCandidates;
+    for (int u = 0; u < 9; ++u){
+        all &= rows[u] & cols[u] & sets[u];
+    }
+    return all == kAllCandidates;
+}
+
+KERNEL_BODY int extract_digits_body(CandidateMask mask, int *digits){
+    unsigned bits = mask;
+    int n = 0;
+    while (bits){
+        digits[n++] = __builtin_ctz(bits);
+        bits &= bits - 1;
+    }
+    return n;
+}
+
+KERNEL_BODY int popcount_body(CandidateMask mask){
+    return __builtin_popcount(mask);
+}
+
+} // end anonymous namespace
+
+////////////////////////////////////////////////////////////////////
+// Instruction set variants
+////////////////////////////////////////////////////////////////////
+
+#define DEFINE_KERNELS(variant, attributes) \
+    attributes static void compute_candidates_##variant(const int *cells, CandidateMask *masks){ \
+        compute_candidates_body(cells, masks); } \
+    attributes static bool is_valid_##variant(const int *cells){ \
+        return is_valid_body(cells); } \
+    attributes static bool is_consistent_##variant(const int *cells, const CandidateMask *masks){ \
+        return is_consistent_body(cells, masks); } \
+    attributes static int extract_digits_##variant(CandidateMask mask, int *digits){ \
+        return extract_digits_body(mask, digits); } \
+    attributes static int popcount_##variant(CandidateMask mask){ \
+        return popcount_body(mask); } \
+    static const SudokuKernels kernels_##variant = { #variant, \
+        compute_candidates_##variant, is_valid_##variant, is_consistent_##variant, \
+        extract_digits_##variant, popcount_##variant };
+
+DEFINE_KERNELS(generic, )
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SUDOKU_X86_KERNELS
+DEFINE_KERNELS(sse42, __attribute__((target("sse4.2,popcnt"))))
+DEFINE_KERNELS(avx2, __attribute__((target("avx2,bmi,bmi2,popcnt"))))
+DEFINE_KERNELS(avx512, __attribute__((target("avx512f,avx512bw,avx512vl,avx2,bmi,bmi2,popcnt"))))
+#endif
+
+////////////////////////////////////////////////////////////////////
+// Dispatch
+////////////////////////////////////////////////////////////////////
+
+vector<const SudokuKernels*> supported_kernels(){
+    vector<const SudokuKernels*> supported;
+    supported.push_back(&kernels_generic);
+#ifdef SUDOKU_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")){
+        supported.push_back(&kernels_sse42);
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi") && 
+            __builtin_cpu_supports("bmi2")){
+            supported.push_back(&kernels_avx2);
+            if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && 
+                __builtin_cpu_supports("avx512vl")){
+                supported.push_back(&kernels_avx512);
+            }
+        }
+    }
+#endif
+    return supported;
+}
+
+static const SudokuKernels* select_kernels(){
+    vector<const SudokuKernels*> supported = supported_kernels();
+    const char *forced = getenv("SUDOKU_KERNELS");
+    if (forced != NULL){
+        for (int k = 0; k < supported.size(); ++k){
+            if (string(forced) == supported[k]->name) return supported[k];
+        }
+        cerr << "SUDOKU_KERNELS=" << forced << " is not supported on this CPU; using "
+             << supported.back()->name << endl;
+    }
+    return supported.back();
+}
+
+const SudokuKernels& kernels(){
+    static const SudokuKernels *selected = select_kernels();
+    return *selected;
+}
+
+////////////////////////////////////////////////////////////////////
+// Cross variant check
+////////////////////////////////////////////////////////////////////
+
+static bool same_results(const SudokuKernels &a, const SudokuKernels &b, const int *cells){
+    CandidateMask masks_a[81], masks_b[81];
+    a.compute_candidates(cells, masks_a);
+    b.compute_candidates(cells, masks_b);
+    if (memcmp(masks_a, masks_b, sizeof(masks_a)) != 0) return false;
+    if (a.is_valid(cells) != b.is_valid(cells)) return false;
+    return a.is_consistent(cells, masks_a) == b.is_consistent(cells, masks_a);
+}
+
+bool check_kernels(const int *cells, ostream &os){
+    vector<const SudokuKernels*> supported = supported_kernels();
+    const SudokuKernels &reference = *supported.front();
+    bool all_ok = true;
+    for (int k = 0; k < supported.size(); ++k){
+        const SudokuKernels &variant = *supported[k];
+        bool ok = same_results(reference, variant, cells);
+
+        // Every value, legal or not, in every cell.
+        int derived[81];
+        for (int c = 0; c < 81 && ok; ++c){
+            memcpy(derived, cells, sizeof(derived));
+            for (int value = -1; value < 9 && ok; ++value){
+                derived[c] = value;
+                ok = same_results(reference, variant, derived);
+            }
+        }
+
+        int digits_a[9], digits_b[9];
+        for (int mask = 0; mask <= kAllCandidates && ok; ++mask){
+            int n = reference.extract_digits(mask, digits_a);
+            ok = n == variant.extract_digits(mask, digits_b) &&
+                memcmp(digits_a, digits_b, n*sizeof(int)) == 0 &&
+                reference.popcount(mask) == variant.popcount(mask);
+        }
+        os << "kernels " << variant.name << ": " << (ok?"ok":"MISMATCH") << endl;
+        all_ok = all_ok && ok;
+    }
+    return all_ok;
+}
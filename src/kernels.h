@@ -0,0 +1,67 @@
+// This file is part of SudokuSover, a simple implementation of search for
+// solving sudoku puzzles.
+// 
+// Copyright (C) 2011 Nathan Ratliff <ratliff.nathan@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the LGNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the LGNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef _KERNELS_H_
+#define _KERNELS_H_
+
+#include <iostream>
+#include <vector>
+
+// Bit d of a candidate mask is set when digit d (0-8) may still be placed.
+typedef unsigned short CandidateMask;
+const CandidateMask kAllCandidates = 0x1ff;
+
+// Board level bit manipulation kernels.  Each kernel is compiled once per
+// supported instruction set and the best variant for the running CPU is
+// chosen on first use.  Every variant returns identical results.
+//
+// All kernels take the 81 cells of a board in row major order, using the
+// internal representation (digits 0-8, -1 for blank).
+struct SudokuKernels{
+    const char *name;
+
+    // Writes the candidate mask of every cell; filled cells get 0.
+    void (*compute_candidates)(const int *cells, CandidateMask *masks);
+
+    // True if no row, column or set contains the same digit twice.
+    bool (*is_valid)(const int *cells);
+
+    // True if every row, column and set can still contain digits 1 through
+    // 9, counting both placed digits and the candidates of blank cells.
+    bool (*is_consistent)(const int *cells, const CandidateMask *masks);
+
+    // Writes the digits of mask in ascending order, returning how many.
+    int (*extract_digits)(CandidateMask mask, int *digits);
+
+    int (*popcount)(CandidateMask mask);
+};
+
+// The kernels selected for this CPU.  Setting the SUDOKU_KERNELS environment
+// variable to a variant name forces that variant if the CPU supports it.
+const SudokuKernels& kernels();
+
+// Every variant the running CPU can execute, from most to least generic.
+std::vector<const SudokuKernels*> supported_kernels();
+
+// Runs every supported variant on cells and on boards derived from it by
+// overwriting single cells, comparing the results against the generic
+// variant.  Reports each variant to os and returns false on any mismatch.
+bool check_kernels(const int *cells, std::ostream &os);
+
+#endif // _KERNELS_H_
@@ -0,0 +1,248 @@
+// This file is part of SudokuSover, a simple implementation of search for
+// solving sudoku puzzles.
+// 
+// Copyright (C) 2011 Nathan Ratliff <ratliff.nathan@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the LGNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the LGNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "search_driver.h"
+#include "timer.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+SearchDriver::SearchDriver(const Board &board): 
+    initial_(board), live_depth_(0), table_(NULL), started_(false), exhausted_(false), 
+    solutions_(0), nodes_(0), checkpoint_interval_(0), last_checkpoint_(0), 
+    checkpoint_due_(false), stop_requested_(0)
+{
+    for (int c = 0; c < 81; ++c) cells_[c] = initial_(c);
+    hash_ = zobrist_hash(cells_);
+    stack_.reserve(81);
+}
+
+Board SearchDriver::board() const{
+    Board board;
+    for (int c = 0; c < 81; ++c) board(c) = cells_[c];
+    return board;
+}
+
+SearchDriver::Expansion SearchDriver::expand(){
+    OCEAN_PROFILE_SCOPE("expand");
+    const SudokuKernels &k = kernels();
+    CandidateMask masks[81];
+    k.compute_candidates(cells_, masks);
+
+    int best = -1, best_count = 10;
+    for (int c = 0; c < 81; ++c){
+        if (cells_[c] >= 0) continue;
+        int count = k.popcount(masks[c]);
+        if (count == 0) return DEAD;
+        if (count < best_count){
+            best = c;
+            best_count = count;
+        }
+    }
+    if (best == -1) return SOLVED;
+    if (!k.is_consistent(cells_, masks)) return DEAD;
+
+    Frame frame;
+    frame.cell = best;
+    frame.value = -1;
+    frame.remaining = masks[best];
+    stack_.push_back(frame);
+    return OPEN;
+}
+
+bool SearchDriver::next_solution(){
+    OCEAN_PROFILE_SCOPE("search");
+    checkpoint_due_ = false;
+    if (!started_){
+        started_ = true;
+        if (table_ != NULL && table_->is_dead(hash_)){
+            exhausted_ = true;
+            return false;
+        }
+        Expansion root = kernels().is_valid(cells_)?expand():DEAD;
+        if (root == SOLVED){
+            ++solutions_;
+            return true;
+        }
+        if (root == DEAD){
+            // Recorded so a search from the same board ends at the probe above.
+            if (table_ != NULL) table_->record_dead(hash_);
+            exhausted_ = true;
+            return false;
+        }
+    }
+
+    while (!stack_.empty()){
+        // Everything below the top frame's current value has been explored,
+        // so this is a safe point to stop or checkpoint.
+        if (stop_requested_) return false;
+        if (checkpoint_interval_ > 0 && nodes_ - last_checkpoint_ >= checkpoint_interval_){
+            last_checkpoint_ = nodes_;
+            checkpoint_due_ = true;
+            return false;
+        }
+
+        Frame &frame = stack_.back();
+        if (frame.value >= 0){
+            cells_[frame.cell] = -1;
+            hash_ ^= zobrist_key(frame.cell, frame.value);
+        }
+        if (frame.remaining == 0){
+            stack_.pop_back();
+            if (stack_.size() >= live_depth_){
+                if (table_ != NULL) table_->record_dead(hash_);
+            } else {
+                live_depth_ = stack_.size();
+            }
+            continue;
+        }
+        frame.value = __builtin_ctz(frame.remaining);
+        frame.remaining &= frame.remaining - 1;
+        cells_[frame.cell] = frame.value;
+        hash_ ^= zobrist_key(frame.cell, frame.value);
+        ++nodes_;
+
+        if (table_ != NULL && table_->is_dead(hash_)) continue;
+        if (expand() == SOLVED){
+            ++solutions_;
+            live_depth_ = stack_.size();
+            return true;
+        }
+    }
+    exhausted_ = true;
+    return false;
+}
+
+void SearchDriver::set_checkpoint_interval(long long interval){
+    checkpoint_interval_ = interval;
+    last_checkpoint_ = nodes_;
+}
+
+// Checkpoint format (whitespace separated):
+//   sudoku-checkpoint 1
+//   <81 initial cells, -1 for blank>
+//   <started> <exhausted> <solutions> <nodes>
+//   <depth>
+//   <cell> <value> <remaining>   (one line per frame, bottom first)
+// Writes contents to a temporary file and renames it over filepath, syncing
+// the file before the rename and its directory after it, so that after a
+// crash or power loss filepath holds either the old or the new contents.
+static bool replace_file_durably(const string &filepath, const string &contents){
+    string tmp_filepath = filepath + ".tmp";
+    int fd = open(tmp_filepath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    size_t written = 0;
+    while (written < contents.size()){
+        ssize_t n = write(fd, contents.data() + written, contents.size() - written);
+        if (n < 0){
+            close(fd);
+            return false;
+        }
+        written += n;
+    }
+    if (fsync(fd) != 0){
+        close(fd);
+        return false;
+    }
+    if (close(fd) != 0) return false;
+    if (rename(tmp_filepath.c_str(), filepath.c_str()) != 0) return false;
+
+    size_t slash = filepath.rfind('/');
+    string directory = (slash == string::npos)?".":filepath.substr(0, slash + 1);
+    int dir_fd = open(directory.c_str(), O_RDONLY);
+    if (dir_fd < 0) return false;
+    bool synced = fsync(dir_fd) == 0;
+    close(dir_fd);
+    return synced;
+}
+
+bool SearchDriver::save_checkpoint(const string &filepath) const{
+    ostringstream out;
+    out << "sudoku-checkpoint 1" << endl;
+    for (int c = 0; c < 81; ++c){
+        out << initial_(c) << ((c % 9 == 8)?"\n":" ");
+    }
+    out << started_ << " " << exhausted_ << " " << solutions_ << " " << nodes_ << endl;
+    out << stack_.size() << endl;
+    for (int f = 0; f < stack_.size(); ++f){
+        const Frame &frame = stack_[f];
+        out << int(frame.cell) << " " << int(frame.value) << " " << frame.remaining << endl;
+    }
+    return replace_file_durably(filepath, out.str());
+}
+
+bool SearchDriver::load_checkpoint(const string &filepath){
+    ifstream in(filepath.c_str());
+    string magic;
+    int version;
+    in >> magic >> version;
+    if (!in || magic != "sudoku-checkpoint" || version != 1) return false;
+
+    Board initial;
+    for (int c = 0; c < 81; ++c){
+        in >> initial(c);
+        if (initial(c) < -1 || initial(c) > 8) return false;
+    }
+    bool started, exhausted;
+    long long solutions, nodes;
+    int depth;
+    in >> started >> exhausted >> solutions >> nodes >> depth;
+    if (!in || depth < 0 || depth > 81) return false;
+
+    int cells[81];
+    for (int c = 0; c < 81; ++c) cells[c] = initial(c);
+    vector<Frame> stack(depth);
+    for (int f = 0; f < depth; ++f){
+        int cell, value, remaining;
+        in >> cell >> value >> remaining;
+        if (!in || cell < 0 || cell > 80 || value < -1 || value > 8 || 
+            remaining < 0 || remaining > kAllCandidates || cells[cell] != -1) return false;
+        stack[f].cell = cell;
+        stack[f].value = value;
+        stack[f].remaining = remaining;
+        cells[cell] = value;
+    }
+
+    initial_ = initial;
+    for (int c = 0; c < 81; ++c) cells_[c] = cells[c];
+    hash_ = zobrist_hash(cells_);
+    stack_ = stack;
+    // Whether the restored frames found solutions is not saved, so none of
+    // them is ever recorded as dead.
+    live_depth_ = stack_.size();
+    stack_.reserve(81);
+    started_ = started;
+    exhausted_ = exhausted;
+    solutions_ = solutions;
+    nodes_ = nodes;
+    last_checkpoint_ = nodes;
+    return true;
+}
+
+ostream& write_board_line(ostream &os, const Board &board){
+    for (int c = 0; c < 81; ++c){
+        if (board(c) == -1) os << '.';
+        else os << board(c) + 1;
+    }
+    return os;
+}
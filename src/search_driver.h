@@ -0,0 +1,118 @@
+// This file is part of SudokuSover, a simple implementation of search for
+// solving sudoku puzzles.
+// 
+// Copyright (C) 2011 Nathan Ratliff <ratliff.nathan@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the LGNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the LGNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef _SEARCH_DRIVER_H_
+#define _SEARCH_DRIVER_H_
+
+#include "sudoku.h"
+#include "kernels.h"
+#include "transposition_table.h"
+#include <csignal>
+#include <string>
+#include <vector>
+
+// Iterative depth first search with an explicit stack.  Unlike search(), all
+// progress lives in a compact stack of at most 81 frames, so the search can
+// stream every solution with bounded memory, be paused, and be saved to and
+// resumed from a checkpoint file.
+//
+// Each step branches on the blank cell with the fewest candidates and tries
+// its candidates in ascending order.  Branches that leave a blank cell without
+// candidates, or a row, column or set unable to hold some digit, are pruned.
+class SearchDriver{
+public:
+    // One level of the search: the cell being branched on, the candidates
+    // not yet tried, and the value currently placed (-1 before the first).
+    struct Frame{
+        unsigned char cell;
+        signed char value;
+        CandidateMask remaining;
+    };
+
+    SearchDriver(const Board &board = Board());
+
+    // Advances to the next solution, leaving it in board().  Returns false
+    // when the search space is exhausted, a stop was requested, or a
+    // checkpoint is due; call again to continue after the latter two.
+    bool next_solution();
+
+    bool exhausted() const{ return exhausted_; }
+    long long solutions() const{ return solutions_; }
+    long long nodes() const{ return nodes_; }
+    const std::vector<Frame>& stack() const{ return stack_; }
+
+    // The initial board and the board at the current point of the search.
+    const Board& initial_board() const{ return initial_; }
+    Board board() const;
+
+    // Skips boards the table knows to be dead and records every subtree this
+    // driver exhausts without finding a solution, including an unsolvable
+    // initial board.  The table is not owned
+    // and may be shared with other drivers; pass NULL to stop using it.
+    void set_transposition_table(TranspositionTable *table){ table_ = table; }
+
+    // Makes next_solution() return early, with checkpoint_due() set, every
+    // interval nodes (0 disables).  The driver never writes checkpoints
+    // itself: the caller should first flush any solutions it has consumed,
+    // then call save_checkpoint(), so the file never runs ahead of them.
+    void set_checkpoint_interval(long long interval);
+    bool checkpoint_due() const{ return checkpoint_due_; }
+
+    // Writes the full search progress to filepath.  The file is synced and
+    // renamed into place, so a crash leaves either the old or new checkpoint.
+    // May be called whenever next_solution() is not running.
+    bool save_checkpoint(const std::string &filepath) const;
+
+    // Restores progress saved by save_checkpoint().  Returns false, leaving
+    // the driver unchanged, if the file is missing or malformed.
+    bool load_checkpoint(const std::string &filepath);
+
+    // Makes next_solution() return false at its next step, until
+    // clear_stop() is called.  Safe to call from a signal handler.
+    void request_stop(){ stop_requested_ = 1; }
+    void clear_stop(){ stop_requested_ = 0; }
+    bool stop_requested() const{ return stop_requested_ != 0; }
+
+protected:
+    enum Expansion{ DEAD, OPEN, SOLVED };
+
+    // Examines cells_, pushing a frame for the next cell to branch on.
+    Expansion expand();
+
+    Board initial_;
+    int cells_[81];
+    ZobristHash hash_; // of cells_
+    std::vector<Frame> stack_;
+    // Frames below this depth have found a solution within their subtree.
+    int live_depth_;
+    TranspositionTable *table_;
+    bool started_, exhausted_;
+    long long solutions_, nodes_;
+
+    long long checkpoint_interval_, last_checkpoint_;
+    bool checkpoint_due_;
+
+    volatile sig_atomic_t stop_requested_;
+};
+
+// Writes the board as a single line of 81 digits in row major order, with
+// '.' for blanks.
+std::ostream& write_board_line(std::ostream &os, const Board &board);
+
+#endif // _SEARCH_DRIVER_H_
@@ -18,12 +18,17 @@
 
 #include "sudoku.h"
 #include "timer.h"
+#include "search_driver.h"
+#include "sudoku_session.h"
 #include <vector>
 #include <list>
 #include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <cassert>
+#include <cstdlib>
+#include <csignal>
 
 using namespace std;
 
@@ -130,11 +135,21 @@ vector<int> Board::compute_moves(int i, int j){
 }
 
 SudokuMatrix<vector<int> > Board::compute_moves(){
+    vector<CandidateMask> candidates;
+    return compute_moves(candidates);
+}
+
+SudokuMatrix<vector<int> > Board::compute_moves(vector<CandidateMask> &candidates){
+    OCEAN_PROFILE_SCOPE("compute_moves");
+    const SudokuKernels &k = kernels();
+    candidates.resize(81);
+    k.compute_candidates(&elements_[0], &candidates[0]);
+
     SudokuMatrix<vector<int> > moves(height(), width());
-    for (int i = 0; i < height(); ++i){
-        for (int j = 0; j < width(); ++j){
-            moves(i,j) = compute_moves(i,j);
-        }
+    int digits[9];
+    for (int c = 0; c < 81; ++c){
+        int n = k.extract_digits(candidates[c], digits);
+        moves(c).assign(digits, digits + n);
     }
     return moves;
 }
@@ -181,31 +196,29 @@ bool Board::is_valid_set(int s_i, int s_j) const{
 }
 
 bool Board::is_valid() const{
-    for (int i = 0; i < 9; ++i){
-        if (!is_valid_row(i) || !is_valid_col(i)) return false;
-    }
-    for (int s_i = 0; s_i < 3; ++s_i){
-        for (int s_j = 0; s_j < 3; ++s_j){
-            if (!is_valid_set(s_i, s_j)) return false;
-        }
-    }
-    return true;
+    return kernels().is_valid(&elements_[0]);
 }
 
-void Board::load_board(const string &filepath){
+bool Board::load_board(const string &filepath){
+    OCEAN_PROFILE_SCOPE("load_board");
     ifstream in(filepath.c_str());
+    bool valid = true;
     for (int s_i = 0; s_i < 3; ++s_i){
         for (int s_j = 0; s_j < 3; ++s_j){
             SudokuMatrix<int> set(3,3);
             for (int i = 0; i < 9; ++i){
-                int val;
-                in >> val;
+                int val = -1;
+                if (!(in >> val) || val == 0 || val < -1 || val > 9){
+                    valid = false;
+                    val = -1;
+                }
                 set(i) = (val!=-1)?(val-1):-1; // internally represent vector indices
             }
             set_elements(s_i, s_j, set);
         }
     }
     in.close();
+    return valid;
 }
 
 ostream& operator<<(ostream &os, const Board &board){
@@ -237,6 +250,7 @@ ostream& operator<<(ostream &os, const Board &board){
         }
     }
     cout << endl;
+    return os;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -254,7 +268,11 @@ ostream& operator<<(ostream &os, const Position &p){
 
 SudokuState::SudokuState(string filepath): move_matrix_(9,9){
     board_.load_board(filepath);
-    move_matrix_ = board_.compute_moves();
+    update_moves();
+}
+
+SudokuState::SudokuState(const Board &board): board_(board), move_matrix_(9,9){
+    update_moves();
 }
 
 SudokuState::SudokuState(const SudokuState &rhs){
@@ -263,6 +281,8 @@ SudokuState::SudokuState(const SudokuState &rhs){
 SudokuState& SudokuState::operator=(const SudokuState &rhs){
     board_ = rhs.board_;
     move_matrix_ = rhs.move_matrix_;
+    candidates_ = rhs.candidates_;
+    return *this;
 }
 
 const Board& SudokuState::board() const{ return board_; }
@@ -323,7 +343,11 @@ void SudokuState::make_move(const Position &p, int value){
 }
 void SudokuState::make_move(int i, int j, int value){
     board_(i,j) = value;
-    move_matrix_ = board_.compute_moves();
+    update_moves();
+}
+
+void SudokuState::update_moves(){
+    move_matrix_ = board_.compute_moves(candidates_);
 }
 
 bool SudokuState::is_consistent(const vector<vector<int> > &moves, vector<bool> dirty) const{
@@ -381,34 +405,26 @@ bool SudokuState::is_consistent_set(int s_i, int s_j) const{
 // Verifies whether there is the possibility for every row, column, and 
 // set to contain digits 1 through 9.
 bool SudokuState::is_consistent() const{
-    for (int r_i = 0; r_i < board_.height(); ++r_i){
-        if (!is_consistent_row(r_i)) return false;
-    }
-    for (int c_i = 0; c_i < board_.width(); ++c_i){
-        if (!is_consistent_col(c_i)) return false;
-    }
-    for (int s_i = 0; s_i < 3; ++s_i){
-        for (int s_j = 0; s_j < 3; ++s_j){
-            if (!is_consistent_set(s_i, s_j)) return false;
-        }
-    }
-    return true;
+    OCEAN_PROFILE_SCOPE("is_consistent");
+    return kernels().is_consistent(&board_.elements()[0], &candidates_[0]);
 }
 
 ////////////////////////////////////////////////////////////////////
 // Sudoku search implementation
 ////////////////////////////////////////////////////////////////////
 
-void search(SudokuState &state, const vector<Position> &positions, int p_i){
+bool search(SudokuState &state, const vector<Position> &positions, int p_i){
+    OCEAN_PROFILE_SCOPE("search");
     while (p_i < positions.size() && state.move_matrix(positions.at(p_i)).size() == 0) ++p_i;
     if (p_i == positions.size()){
         if (state.is_consistent()){
+            OCEAN_PROFILE_SCOPE("output");
             cout << "consistent solution found." << endl;
             cout << state.board() << endl;
             timer.print_elapse();
-            exit(0);
+            return true;
         }
-        return;
+        return false;
     }
     assert(p_i < positions.size());
     Position p = positions.at(p_i);
@@ -417,9 +433,10 @@ void search(SudokuState &state, const vector<Position> &positions, int p_i){
         SudokuState new_state(state);
         new_state.make_move(p, actions.at(i));
         if (new_state.is_consistent()){
-            search(new_state, positions, p_i + 1);
+            if (search(new_state, positions, p_i + 1)) return true;
         }
     }
+    return false;
 }
 
 
@@ -448,15 +465,215 @@ vector<element_t>& operator++(vector<element_t> &vec){
 // Main implementation
 ////////////////////////////////////////////////////////////////////
 
+static void print_usage(){
+    cout << "usage: sudoku [--profile] [--trace <trace.json>] [--check-kernels] <filepath>" << endl;
+    cout << "       sudoku [--enumerate | --count] [--limit <n>] [--checkpoint <file>]" << endl;
+    cout << "              [--checkpoint-interval <nodes>] (<filepath> | --resume <file>)" << endl;
+    cout << "       sudoku --interactive <filepath>" << endl;
+}
+
+// The driver interrupted by SIGINT/SIGTERM during enumerate().
+static SearchDriver *signal_driver = NULL;
+
+static void stop_on_signal(int){
+    if (signal_driver != NULL) signal_driver->request_stop();
+}
+
+// Streams (or just counts) every solution.  Solutions are written to stdout
+// one per line; progress and totals go to stderr so the stream stays clean.
+//
+// Output is flushed before every checkpoint, so a checkpoint never covers
+// solutions that have not been written.  After a hard kill the stream may
+// hold solutions (and a partial line) past the last checkpoint; keep only
+// as many lines as --resume reports having resumed after.
+//
+// Returns 0 once the search space is exhausted, 2 if the run ended early
+// (--limit, SIGINT or SIGTERM) and can be resumed, and 1 on errors.
+static int enumerate(SearchDriver &driver, bool print, long long limit,
+    const string &checkpoint_filepath, long long checkpoint_interval){
+    if (!checkpoint_filepath.empty()){
+        driver.set_checkpoint_interval(checkpoint_interval);
+        signal_driver = &driver;
+        signal(SIGINT, stop_on_signal);
+        signal(SIGTERM, stop_on_signal);
+    }
+
+    timer.start();
+    long long found = 0;
+    while (limit <= 0 || found < limit){
+        if (driver.next_solution()){
+            ++found;
+            if (print) write_board_line(cout, driver.board()) << "\n";
+            continue;
+        }
+        if (!driver.checkpoint_due()) break;
+        cout.flush();
+        if (!driver.save_checkpoint(checkpoint_filepath)){
+            cerr << "unable to write checkpoint " << checkpoint_filepath << endl;
+        }
+    }
+    cout.flush();
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    signal_driver = NULL;
+
+    cerr << "solutions: " << driver.solutions() << " (" << found << " this run)" << endl;
+    cerr << "nodes: " << driver.nodes() << endl;
+    cerr << (driver.exhausted()?"search complete":"search incomplete") << endl;
+    cerr << "elapse time: " << timer.elapse_time_seconds() << endl;
+    if (!checkpoint_filepath.empty()){
+        if (!driver.save_checkpoint(checkpoint_filepath)){
+            cerr << "unable to write checkpoint " << checkpoint_filepath << endl;
+            return 1;
+        }
+        if (!driver.exhausted()) cerr << "progress saved to " << checkpoint_filepath << endl;
+    }
+    return driver.exhausted()?0:2;
+}
+
+// Line based front end for SudokuSession.  Rows and columns are numbered 0-8
+// as in the printed board, digits 1-9.
+static int interactive(const Board &board){
+    SudokuSession session(board);
+    cout << "commands: set <row> <col> <digit>, clear <row> <col>, solvable, hint," << endl;
+    cout << "          conflicts, solution, print, stats, quit" << endl;
+    string line;
+    while (getline(cin, line)){
+        istringstream in(line);
+        string command;
+        if (!(in >> command)) continue;
+        int i = -1, j = -1, digit = 0;
+        if (command == "set"){
+            in >> i >> j >> digit;
+            cout << (session.set(i, j, digit - 1)?"ok":"invalid") << endl;
+        } else if (command == "clear"){
+            in >> i >> j;
+            cout << (session.clear(i, j)?"ok":"invalid") << endl;
+        } else if (command == "solvable"){
+            cout << (session.is_solvable()?"yes":"no") << endl;
+        } else if (command == "hint"){
+            SudokuSession::Deduction d = session.next_deduction();
+            const char *kinds[] = {"none", "naked single", "hidden single", "from solution"};
+            cout << kinds[d.kind];
+            if (d.kind != SudokuSession::NO_DEDUCTION){
+                cout << ": " << d.position << " = " << d.value + 1;
+            }
+            cout << endl;
+        } else if (command == "conflicts"){
+            vector<Position> conflicts = session.conflicts();
+            for (int c = 0; c < conflicts.size(); ++c) cout << conflicts[c] << " ";
+            cout << "(" << conflicts.size() << ")" << endl;
+        } else if (command == "solution"){
+            Board solved;
+            if (session.solution(solved)) cout << solved << endl;
+            else cout << "no solution" << endl;
+        } else if (command == "stats"){
+            session.table().print_stats(cout);
+        } else if (command == "print"){
+            cout << session.board() << endl;
+        } else if (command == "quit"){
+            break;
+        } else {
+            cout << "unknown command" << endl;
+        }
+    }
+    return 0;
+}
+
 int main(int argc, char **argv){
-    if (argc != 2) {
+    string filepath, trace_filepath, checkpoint_filepath, resume_filepath;
+    bool profile = false, check = false, enumerate_mode = false, print_solutions = false;
+    bool interactive_mode = false;
+    long long limit = 0, checkpoint_interval = 10000000;
+    for (int a = 1; a < argc; ++a){
+        string arg(argv[a]);
+        if (arg == "--profile"){
+            profile = true;
+        } else if (arg == "--interactive"){
+            interactive_mode = true;
+        } else if (arg == "--check-kernels"){
+            check = true;
+        } else if (arg == "--trace" && a + 1 < argc){
+            trace_filepath = argv[++a];
+        } else if (arg == "--enumerate" || arg == "--count"){
+            enumerate_mode = true;
+            print_solutions = (arg == "--enumerate");
+        } else if (arg == "--limit" && a + 1 < argc){
+            limit = atoll(argv[++a]);
+        } else if (arg == "--checkpoint" && a + 1 < argc){
+            enumerate_mode = true;
+            checkpoint_filepath = argv[++a];
+        } else if (arg == "--checkpoint-interval" && a + 1 < argc){
+            checkpoint_interval = atoll(argv[++a]);
+        } else if (arg == "--resume" && a + 1 < argc){
+            enumerate_mode = true;
+            resume_filepath = argv[++a];
+        } else if (arg[0] != '-' && filepath.empty()){
+            filepath = arg;
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+    if (int(check) + int(interactive_mode) + int(enumerate_mode) > 1){
+        cout << "--check-kernels, --interactive and enumeration options "
+             << "cannot be combined." << endl;
+        print_usage();
+        return 1;
+    }
+    if (filepath.empty() == resume_filepath.empty()) {
         cout << "requires filepath argment." << endl;
+        print_usage();
+        return 1;
+    }
+    Ocean::Profiler::enable(profile || !trace_filepath.empty());
+
+    Board board;
+    if (!filepath.empty() && !board.load_board(filepath)){
+        cout << "unable to read a valid board from " << filepath << endl;
         return 1;
     }
-    string filepath(argv[1]);
+
+    if (check){
+        return check_kernels(&board.elements()[0], cout)?0:1;
+    }
+
+    if (interactive_mode){
+        int status = interactive(board);
+        if (profile) Ocean::Profiler::print_summary(cerr);
+        if (!trace_filepath.empty() && !Ocean::Profiler::write_trace(trace_filepath)){
+            cerr << "unable to write trace file " << trace_filepath << endl;
+            return 1;
+        }
+        return status;
+    }
+
+    if (enumerate_mode){
+        SearchDriver driver;
+        if (!resume_filepath.empty()){
+            if (!driver.load_checkpoint(resume_filepath)){
+                cerr << "unable to read checkpoint " << resume_filepath << endl;
+                return 1;
+            }
+            if (checkpoint_filepath.empty()) checkpoint_filepath = resume_filepath;
+            cerr << "resuming after " << driver.solutions() << " solutions" << endl;
+        } else {
+            driver = SearchDriver(board);
+        }
+        int status = enumerate(driver, print_solutions, limit, 
+            checkpoint_filepath, checkpoint_interval);
+        if (profile) Ocean::Profiler::print_summary(cerr);
+        if (!trace_filepath.empty() && !Ocean::Profiler::write_trace(trace_filepath)){
+            cerr << "unable to write trace file " << trace_filepath << endl;
+            return 1;
+        }
+        return status;
+    }
+
     cout << "filepath: " << filepath << endl;
-    SudokuState sudoku_state(filepath);
+    SudokuState sudoku_state(board);
     cout << "initial board state:\n" << sudoku_state.board() << endl;
+    cout << "kernels: " << kernels().name << endl;
 
     vector<Position> positions;
     for (int i = 0; i < 9; ++i){
@@ -467,5 +684,11 @@ int main(int argc, char **argv){
 
     timer.start();
     search(sudoku_state, positions, 0);
+
+    if (profile) Ocean::Profiler::print_summary();
+    if (!trace_filepath.empty() && !Ocean::Profiler::write_trace(trace_filepath)){
+        cout << "unable to write trace file " << trace_filepath << endl;
+        return 1;
+    }
     return 0;
 }
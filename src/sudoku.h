@@ -20,6 +20,7 @@
 #define _SUDOKU_H_
 
 #include "matrix_structure.h"
+#include "kernels.h"
 #include <vector>
 #include <iostream>
 
@@ -46,6 +47,7 @@ public:
 
     std::vector<int> compute_moves(int i, int j);
     SudokuMatrix<std::vector<int> > compute_moves();
+    SudokuMatrix<std::vector<int> > compute_moves(std::vector<CandidateMask> &candidates);
 
     void set_elements(int set_i, int set_j, const SudokuMatrix<int> &set);
     static bool is_valid(const std::vector<int> &elements);
@@ -55,7 +57,9 @@ public:
     bool is_valid_set(int s_i, int s_j) const;
     bool is_valid() const;
 
-    void load_board(const std::string &filepath);
+    // Returns false if the file is unreadable, too short, or holds a value
+    // other than -1 or 1 through 9; such values are loaded as blanks.
+    bool load_board(const std::string &filepath);
 };
 std::ostream& operator<<(std::ostream &os, const Board &board);
 
@@ -76,6 +80,7 @@ std::ostream& operator<<(std::ostream &os, const Position &p);
 class SudokuState{
 public:
     SudokuState(std::string filepath="file.txt");
+    SudokuState(const Board &board);
     SudokuState(const SudokuState &rhs);
     SudokuState& operator=(const SudokuState &rhs);
 
@@ -111,11 +116,16 @@ public:
     bool is_consistent() const;
 
 protected:
+    void update_moves();
+
     Board board_;
     SudokuMatrix<std::vector<int> > move_matrix_;
+    std::vector<CandidateMask> candidates_; // row major, mirrors move_matrix_
 };
 
-void search(SudokuState &state, const std::vector<Position> &positions, int p_i);
+// Depth first search over the given positions.  Prints the first consistent
+// solution found and returns true, or returns false if there is none.
+bool search(SudokuState &state, const std::vector<Position> &positions, int p_i);
 
 template<class element_t>
 std::ostream& operator<<(std::ostream &os, const std::vector<element_t> &vec);
@@ -0,0 +1,193 @@
+// This file is part of SudokuSover, a simple implementation of search for
+// solving sudoku puzzles.
+// 
+// Copyright (C) 2011 Nathan Ratliff <ratliff.nathan@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the LGNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the LGNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "sudoku_session.h"
+#include "search_driver.h"
+#include "timer.h"
+
+using namespace std;
+
+static inline int set_index(int cell){ return (cell/27)*3 + (cell%9)/3; }
+
+SudokuSession::SudokuSession(const Board &board, int table_log2_entries): 
+    conflicts_(0), solution_valid_(false), mismatches_(0), table_(table_log2_entries)
+{
+    for (int u = 0; u < 9; ++u){
+        for (int d = 0; d < 9; ++d){
+            row_counts_[u][d] = col_counts_[u][d] = set_counts_[u][d] = 0;
+        }
+        row_used_[u] = col_used_[u] = set_used_[u] = 0;
+    }
+    for (int c = 0; c < 81; ++c) cells_[c] = -1;
+    for (int c = 0; c < 81; ++c){
+        given_[c] = board(c) >= 0 && board(c) <= 8;
+        if (given_[c]) place(c, board(c), 1);
+    }
+}
+
+void SudokuSession::add_to_unit(unsigned char *counts, unsigned short &used, 
+    int value, int delta){
+    unsigned char &count = counts[value];
+    if (delta > 0){
+        if (count == 1) ++conflicts_;
+        ++count;
+    } else {
+        --count;
+        if (count == 1) --conflicts_;
+    }
+    if (count > 0) used |= 1 << value;
+    else used &= ~(1 << value);
+}
+
+// Adds (delta = 1) or removes (delta = -1) value at cell, keeping counts,
+// conflicts and solution agreement in step.
+void SudokuSession::place(int cell, int value, int delta){
+    add_to_unit(row_counts_[cell/9], row_used_[cell/9], value, delta);
+    add_to_unit(col_counts_[cell%9], col_used_[cell%9], value, delta);
+    add_to_unit(set_counts_[set_index(cell)], set_used_[set_index(cell)], value, delta);
+    if (solution_valid_ && solution_[cell] != value) mismatches_ += delta;
+    cells_[cell] = (delta > 0)?value:-1;
+}
+
+bool SudokuSession::set(int i, int j, int value){
+    if (i < 0 || i > 8 || j < 0 || j > 8 || value < 0 || value > 8) return false;
+    int cell = 9*i + j;
+    if (given_[cell]) return false;
+    if (cells_[cell] == value) return true;
+    if (cells_[cell] != -1) place(cell, cells_[cell], -1);
+    place(cell, value, 1);
+    return true;
+}
+
+bool SudokuSession::clear(int i, int j){
+    if (i < 0 || i > 8 || j < 0 || j > 8) return false;
+    int cell = 9*i + j;
+    if (given_[cell]) return false;
+    if (cells_[cell] != -1) place(cell, cells_[cell], -1);
+    return true;
+}
+
+Board SudokuSession::board() const{
+    Board board;
+    for (int c = 0; c < 81; ++c) board(c) = cells_[c];
+    return board;
+}
+
+CandidateMask SudokuSession::candidates(int i, int j) const{
+    if (cells_[9*i + j] != -1) return 0;
+    return ~(row_used_[i] | col_used_[j] | set_used_[set_index(9*i + j)]) & kAllCandidates;
+}
+
+vector<Position> SudokuSession::conflicts() const{
+    OCEAN_PROFILE_SCOPE("conflicts");
+    vector<Position> positions;
+    if (conflicts_ == 0) return positions;
+    for (int c = 0; c < 81; ++c){
+        int v = cells_[c];
+        if (v != -1 && (row_counts_[c/9][v] > 1 || col_counts_[c%9][v] > 1 || 
+                set_counts_[set_index(c)][v] > 1)){
+            positions.push_back(Position(c/9, c%9));
+        }
+    }
+    return positions;
+}
+
+bool SudokuSession::is_solvable(){
+    OCEAN_PROFILE_SCOPE("is_solvable");
+    if (conflicts_ > 0) return false;
+    if (solution_valid_ && mismatches_ == 0) return true;
+
+    // The driver records the board in table_ if it proves it unsolvable.
+    SearchDriver driver(board());
+    driver.set_transposition_table(&table_);
+    if (!driver.next_solution()) return false;
+    Board solved = driver.board();
+    for (int c = 0; c < 81; ++c) solution_[c] = solved(c);
+    solution_valid_ = true;
+    mismatches_ = 0;
+    return true;
+}
+
+bool SudokuSession::solution(Board &board){
+    if (!is_solvable()) return false;
+    for (int c = 0; c < 81; ++c) board(c) = solution_[c];
+    return true;
+}
+
+SudokuSession::Deduction SudokuSession::next_deduction(){
+    OCEAN_PROFILE_SCOPE("next_deduction");
+    Deduction deduction;
+    deduction.kind = NO_DEDUCTION;
+    deduction.value = -1;
+    // Singles on an unsolvable board would lead the player further astray.
+    if (!is_solvable()) return deduction;
+
+    CandidateMask masks[81];
+    int best = -1, best_count = 10;
+    for (int c = 0; c < 81; ++c){
+        masks[c] = candidates(c/9, c%9);
+        if (cells_[c] != -1) continue;
+        int count = __builtin_popcount(masks[c]);
+        if (count == 0) return deduction;
+        if (count < best_count){
+            best = c;
+            best_count = count;
+        }
+    }
+    if (best == -1) return deduction;
+    if (best_count == 1){
+        deduction.kind = NAKED_SINGLE;
+        deduction.position = Position(best/9, best%9);
+        deduction.value = __builtin_ctz(masks[best]);
+        return deduction;
+    }
+
+    // Hidden singles: a digit that fits exactly one cell of a unit.  Units
+    // 0-8 are rows, 9-17 columns and 18-26 sets.
+    for (int u = 0; u < 27; ++u){
+        unsigned once = 0, twice = 0;
+        int unit_cells[9];
+        for (int k = 0; k < 9; ++k){
+            int i, j;
+            if (u < 9){ i = u; j = k; }
+            else if (u < 18){ i = k; j = u - 9; }
+            else { i = ((u - 18)/3)*3 + k/3; j = ((u - 18)%3)*3 + k%3; }
+            unit_cells[k] = 9*i + j;
+            twice |= once & masks[unit_cells[k]];
+            once |= masks[unit_cells[k]];
+        }
+        unsigned singles = once & ~twice;
+        if (singles){
+            int value = __builtin_ctz(singles);
+            for (int k = 0; k < 9; ++k){
+                if (masks[unit_cells[k]] & (1 << value)){
+                    deduction.kind = HIDDEN_SINGLE;
+                    deduction.position = Position(unit_cells[k]/9, unit_cells[k]%9);
+                    deduction.value = value;
+                    return deduction;
+                }
+            }
+        }
+    }
+
+    deduction.kind = FROM_SOLUTION;
+    deduction.position = Position(best/9, best%9);
+    deduction.value = solution_[best];
+    return deduction;
+}
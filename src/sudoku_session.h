@@ -0,0 +1,104 @@
+// This file is part of SudokuSover, a simple implementation of search for
+// solving sudoku puzzles.
+// 
+// Copyright (C) 2011 Nathan Ratliff <ratliff.nathan@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the LGNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the LGNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef _SUDOKU_SESSION_H_
+#define _SUDOKU_SESSION_H_
+
+#include "sudoku.h"
+#include "kernels.h"
+#include "transposition_table.h"
+#include <vector>
+
+// Long lived puzzle state for interactive play.  Player edits update digit
+// counts for the cell's row, column and set in constant time, so candidates
+// and conflicts never require a pass over the whole board.  The solution is
+// cached once found and kept as long as the player's entries agree with it.
+// Boards proven unsolvable are remembered in a transposition table, so
+// asking again about the same board costs a single probe.
+//
+// Rows, columns and values use the internal representation (0-8).
+class SudokuSession{
+public:
+    enum DeductionKind{
+        NO_DEDUCTION,   // board is full, has conflicts, or has no solution
+        NAKED_SINGLE,   // the cell has a single candidate
+        HIDDEN_SINGLE,  // the only cell of a row, column or set that can hold value
+        FROM_SOLUTION   // no single exists; value taken from the solution
+    };
+    struct Deduction{
+        DeductionKind kind;
+        Position position;
+        int value;
+    };
+
+    // The filled cells of board become givens, which cannot be edited.
+    // Values outside 0-8 are treated as blanks.
+    explicit SudokuSession(const Board &board = Board(), int table_log2_entries = 16);
+
+    // Both return false, changing nothing, for givens or values out of range.
+    bool set(int i, int j, int value);
+    bool clear(int i, int j);
+
+    int value(int i, int j) const{ return cells_[9*i + j]; }
+    bool is_given(int i, int j) const{ return given_[9*i + j]; }
+    Board board() const;
+
+    // Digits not yet used in the cell's row, column or set.
+    CandidateMask candidates(int i, int j) const;
+
+    bool has_conflicts() const{ return conflicts_ > 0; }
+    // Filled cells sharing their digit with another cell of a row, column
+    // or set.
+    std::vector<Position> conflicts() const;
+
+    // Whether the current entries can be completed into a solution.
+    bool is_solvable();
+    // Copies the cached solution into board; false if unsolvable.
+    bool solution(Board &board);
+
+    // A deduction for a blank cell, preferring logical singles.  Checks
+    // is_solvable() first, so hints are only given on solvable boards; this
+    // is free while the cached solution still agrees with the entries.
+    Deduction next_deduction();
+
+    const TranspositionTable& table() const{ return table_; }
+
+protected:
+    void place(int cell, int value, int delta);
+    void add_to_unit(unsigned char *counts, unsigned short &used, int value, int delta);
+
+    int cells_[81];
+    bool given_[81];
+
+    // counts[unit][digit] and the mask of digits with a nonzero count.
+    unsigned char row_counts_[9][9], col_counts_[9][9], set_counts_[9][9];
+    unsigned short row_used_[9], col_used_[9], set_used_[9];
+    // Number of (unit, digit) pairs appearing more than once.
+    int conflicts_;
+
+    // Cached solution; valid while no filled cell disagrees with it.
+    bool solution_valid_;
+    int solution_[81];
+    int mismatches_;
+
+    // Hashes of boards, and subtrees, that searches found to be dead.
+    TranspositionTable table_;
+};
+
+#endif // _SUDOKU_SESSION_H_
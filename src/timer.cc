@@ -19,18 +19,28 @@
 #include "timer.h"
 
 #include <cstdlib>
+#include <cstdio>
 #include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <mutex>
 
 using namespace std;
 using namespace Ocean;
 
-void Timer::start(){ gettimeofday(&start_time_, NULL); }
+unsigned long long Ocean::monotonic_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+}
+
+void Timer::start(){ start_time_ = monotonic_ns(); }
 
 // returns time in milliseconds.
 double Timer::elapse_time(){
-    gettimeofday(&end_time_, NULL);
-    return (end_time_.tv_sec-start_time_.tv_sec)*1000.0 + 
-        (end_time_.tv_usec-start_time_.tv_usec)/1000.0;
+    end_time_ = monotonic_ns();
+    return (end_time_ - start_time_)/1000000.0;
 }
 
 double Timer::elapse_time_seconds(){
@@ -42,3 +52,168 @@ double Timer::print_elapse(){
     cout << "elapse time: " << elapse_time << endl;
     return elapse_time;
 }
+
+////////////////////////////////////////////////////////////////////
+// Profiler implementation
+////////////////////////////////////////////////////////////////////
+
+namespace{
+
+// Trace events beyond this many per thread are dropped (the summary still
+// counts them).
+const size_t kMaxEventsPerThread = 1 << 18;
+
+struct ProfileEvent{
+    const char *name;
+    unsigned long long start, end;
+};
+
+struct OpenScope{
+    const char *name;
+    unsigned long long start;
+    unsigned long long child_ns;
+    int aggregate;
+};
+
+struct Aggregate{
+    const char *name;
+    long long count;
+    unsigned long long total_ns;
+    unsigned long long self_ns;
+    int open; // number of instances currently on the scope stack
+};
+
+struct ThreadBuffer{
+    int tid;
+    vector<ProfileEvent> events;
+    vector<OpenScope> stack;
+    vector<Aggregate> aggregates;
+    long long dropped;
+};
+
+mutex registry_mutex;
+vector<ThreadBuffer*> registry;
+unsigned long long profile_epoch = 0;
+thread_local ThreadBuffer *tls_buffer = NULL;
+
+// Buffers are owned by the registry and never freed, so scopes recorded
+// by worker threads that have since exited can still be exported.
+ThreadBuffer& thread_buffer(){
+    if (tls_buffer == NULL){
+        tls_buffer = new ThreadBuffer();
+        tls_buffer->dropped = 0;
+        lock_guard<mutex> lock(registry_mutex);
+        tls_buffer->tid = registry.size() + 1;
+        registry.push_back(tls_buffer);
+    }
+    return *tls_buffer;
+}
+
+int find_aggregate(ThreadBuffer &buffer, const char *name){
+    for (int i = 0; i < buffer.aggregates.size(); ++i){
+        if (buffer.aggregates[i].name == name) return i;
+    }
+    Aggregate agg = {name, 0, 0, 0, 0};
+    buffer.aggregates.push_back(agg);
+    return buffer.aggregates.size() - 1;
+}
+
+void write_json_string(ostream &os, const char *str){
+    os << '"';
+    for (const char *c = str; *c; ++c){
+        if (*c == '"' || *c == '\\') os << '\\';
+        os << *c;
+    }
+    os << '"';
+}
+
+} // end anonymous namespace
+
+bool Profiler::enabled_ = false;
+
+void Profiler::enable(bool on){
+    if (on && profile_epoch == 0) profile_epoch = monotonic_ns();
+    enabled_ = on;
+}
+
+void ProfileScope::begin(const char *name){
+    ThreadBuffer &buffer = thread_buffer();
+    OpenScope scope;
+    scope.name = name;
+    scope.child_ns = 0;
+    scope.aggregate = find_aggregate(buffer, name);
+    ++buffer.aggregates[scope.aggregate].open;
+    buffer.stack.push_back(scope);
+    buffer.stack.back().start = monotonic_ns();
+}
+
+void ProfileScope::end(){
+    unsigned long long now = monotonic_ns();
+    ThreadBuffer &buffer = thread_buffer();
+    OpenScope scope = buffer.stack.back();
+    buffer.stack.pop_back();
+
+    unsigned long long duration = now - scope.start;
+    Aggregate &agg = buffer.aggregates[scope.aggregate];
+    ++agg.count;
+    agg.self_ns += duration - scope.child_ns;
+    if (--agg.open == 0) agg.total_ns += duration;
+    if (!buffer.stack.empty()) buffer.stack.back().child_ns += duration;
+
+    if (buffer.events.size() < kMaxEventsPerThread){
+        ProfileEvent event = {scope.name, scope.start, now};
+        buffer.events.push_back(event);
+    } else {
+        ++buffer.dropped;
+    }
+}
+
+bool Profiler::write_trace(const string &filepath){
+    ofstream out(filepath.c_str());
+    if (!out) return false;
+
+    lock_guard<mutex> lock(registry_mutex);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    out << fixed << setprecision(3);
+    bool first = true;
+    for (int t = 0; t < registry.size(); ++t){
+        const ThreadBuffer &buffer = *registry[t];
+        for (int e = 0; e < buffer.events.size(); ++e){
+            const ProfileEvent &event = buffer.events[e];
+            out << (first?"\n":",\n") << "{\"name\":";
+            write_json_string(out, event.name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer.tid
+                << ",\"ts\":" << (event.start - profile_epoch)/1000.0
+                << ",\"dur\":" << (event.end - event.start)/1000.0 << "}";
+            first = false;
+        }
+    }
+    out << "\n]}" << endl;
+    return out.good();
+}
+
+void Profiler::print_summary(ostream &os){
+    lock_guard<mutex> lock(registry_mutex);
+    for (int t = 0; t < registry.size(); ++t){
+        const ThreadBuffer &buffer = *registry[t];
+        os << "thread " << buffer.tid << ":" << endl;
+        os << "  " << left << setw(16) << "scope" << right
+           << setw(12) << "calls" 
+           << setw(14) << "total (ms)" 
+           << setw(14) << "self (ms)" 
+           << setw(16) << "self/call (us)" << endl;
+        for (int a = 0; a < buffer.aggregates.size(); ++a){
+            const Aggregate &agg = buffer.aggregates[a];
+            os << "  " << left << setw(16) << agg.name << right
+               << setw(12) << agg.count
+               << fixed << setprecision(3)
+               << setw(14) << agg.total_ns/1e6
+               << setw(14) << agg.self_ns/1e6
+               << setw(16) << (agg.count?agg.self_ns/1e3/agg.count:0.0) << endl;
+            os.unsetf(ios::floatfield);
+        }
+        if (buffer.dropped > 0){
+            os << "  (" << buffer.dropped << " trace events dropped)" << endl;
+        }
+    }
+}
@@ -19,10 +19,17 @@
 #ifndef TIMER_H
 #define TIMER_H
 
-#include <sys/time.h>
+#include <time.h>
+#include <iostream>
+#include <string>
 
 namespace Ocean{
 
+/** @brief Reads the monotonic clock (CLOCK_MONOTONIC).
+ *  @return The current time in nanoseconds from an arbitrary epoch.
+ */
+unsigned long long monotonic_ns();
+
 /** @brief Simple lightweight timing class.
  */
 class Timer{
@@ -53,11 +60,78 @@ public:
     double print_elapse();
 	
 protected:
-	struct timeval start_time_;
-	struct timeval end_time_;
+	unsigned long long start_time_;
+	unsigned long long end_time_;
+};
+
+/** @brief Collects nested timing scopes into per-thread buffers.
+ *
+ *  Profiling is off by default; a disabled ProfileScope costs a single
+ *  branch.  When enabled, each thread records into its own buffer so no
+ *  locking happens on the hot path.  Recorded scopes can be exported as a
+ *  Chrome/Perfetto trace or summarized as a table.
+ */
+class Profiler{
+public:
+    /** @brief Turns recording on or off for all threads.
+     *
+     *  Call before starting any worker threads; the flag is not atomic.
+     */
+    static void enable(bool on = true);
+    static bool enabled(){ return enabled_; }
+
+    /** @brief Writes every recorded scope as Chrome trace event JSON.
+     *
+     *  The file can be loaded in chrome://tracing or ui.perfetto.dev.
+     *  @return false if the file could not be written.
+     */
+    static bool write_trace(const std::string &filepath);
+
+    /** @brief Prints per-thread call counts, inclusive and self times.
+     *
+     *  Inclusive time of a recursive scope is only counted once, at its
+     *  outermost instance.
+     */
+    static void print_summary(std::ostream &os = std::cout);
+
+protected:
+    static bool enabled_;
+};
+
+/** @brief RAII scope recorded by the Profiler.
+ *
+ *  The name must be a string literal (or otherwise outlive the profiler);
+ *  scopes are aggregated by name pointer.
+ */
+class ProfileScope{
+public:
+    explicit ProfileScope(const char *name): active_(Profiler::enabled()){
+        if (active_) begin(name);
+    }
+    ~ProfileScope(){
+        if (active_) end();
+    }
+
+protected:
+    static void begin(const char *name);
+    static void end();
+
+    bool active_;
+
+private:
+    ProfileScope(const ProfileScope &);
+    ProfileScope& operator=(const ProfileScope &);
 };
 
 } // end namespace ocean
 
+#define OCEAN_PROFILE_CONCAT_(a, b) a ## b
+#define OCEAN_PROFILE_CONCAT(a, b) OCEAN_PROFILE_CONCAT_(a, b)
+
+/** @brief Profiles the rest of the enclosing block under the given name.
+ */
+#define OCEAN_PROFILE_SCOPE(name) \
+    Ocean::ProfileScope OCEAN_PROFILE_CONCAT(ocean_profile_scope_, __LINE__)(name)
+
 #endif // TIMER_H
 
@@ -0,0 +1,105 @@
+// This file is part of SudokuSover, a simple implementation of search for
+// solving sudoku puzzles.
+// 
+// Copyright (C) 2011 Nathan Ratliff <ratliff.nathan@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the LGNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the LGNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "transposition_table.h"
+
+using namespace std;
+
+namespace{
+
+const ZobristHash kEmptyBoardHash = 0x9e3779b97f4a7c15ULL;
+
+ZobristHash splitmix64(ZobristHash &state){
+    ZobristHash z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Generated from a fixed seed so hashes are stable across runs.
+struct ZobristKeys{
+    ZobristHash keys[81][9];
+    ZobristKeys(){
+        ZobristHash state = 2011;
+        for (int c = 0; c < 81; ++c){
+            for (int v = 0; v < 9; ++v){
+                keys[c][v] = splitmix64(state);
+            }
+        }
+    }
+};
+const ZobristKeys zobrist;
+
+} // end anonymous namespace
+
+ZobristHash zobrist_key(int cell, int value){
+    return zobrist.keys[cell][value];
+}
+
+ZobristHash zobrist_hash(const int *cells){
+    ZobristHash hash = kEmptyBoardHash;
+    for (int c = 0; c < 81; ++c){
+        if (cells[c] >= 0) hash ^= zobrist.keys[c][cells[c]];
+    }
+    return hash;
+}
+
+////////////////////////////////////////////////////////////////////
+// TranspositionTable implementation
+////////////////////////////////////////////////////////////////////
+
+int TranspositionTable::clamp_log2_entries(int log2_entries){
+    if (log2_entries < 1) return 1;
+    if (log2_entries > kMaxLog2Entries) return kMaxLog2Entries;
+    return log2_entries;
+}
+
+TranspositionTable::TranspositionTable(int log2_entries): 
+    entries_(size_t(1) << clamp_log2_entries(log2_entries)), 
+    mask_((ZobristHash(1) << clamp_log2_entries(log2_entries)) - 1),
+    hits_(0), misses_(0), stores_(0)
+{
+    clear();
+}
+
+// Zero marks an empty slot; a board hashing to zero is simply never stored.
+bool TranspositionTable::is_dead(ZobristHash hash){
+    bool dead = hash != 0 && entries_[hash & mask_].load(memory_order_relaxed) == hash;
+    (dead?hits_:misses_).fetch_add(1, memory_order_relaxed);
+    return dead;
+}
+
+void TranspositionTable::record_dead(ZobristHash hash){
+    entries_[hash & mask_].store(hash, memory_order_relaxed);
+    stores_.fetch_add(1, memory_order_relaxed);
+}
+
+void TranspositionTable::clear(){
+    for (size_t e = 0; e < entries_.size(); ++e){
+        entries_[e].store(0, memory_order_relaxed);
+    }
+}
+
+void TranspositionTable::print_stats(ostream &os) const{
+    long long probes = hits() + misses();
+    os << "transposition table: " << size() << " entries, "
+       << hits() << " hits, " << misses() << " misses ("
+       << (probes?100.0*hits()/probes:0.0) << "% hit rate), "
+       << stores() << " dead subtrees stored" << endl;
+}
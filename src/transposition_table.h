@@ -0,0 +1,75 @@
+// This file is part of SudokuSover, a simple implementation of search for
+// solving sudoku puzzles.
+// 
+// Copyright (C) 2011 Nathan Ratliff <ratliff.nathan@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the LGNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the LGNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef _TRANSPOSITION_TABLE_H_
+#define _TRANSPOSITION_TABLE_H_
+
+#include <atomic>
+#include <iostream>
+#include <vector>
+
+typedef unsigned long long ZobristHash;
+
+// Zobrist key of digit value (0-8) placed in cell (0-80, row major).  The
+// hash of a board is the XOR of the keys of its filled cells with a nonzero
+// base, so placing or clearing a digit updates it with a single XOR.
+ZobristHash zobrist_key(int cell, int value);
+ZobristHash zobrist_hash(const int *cells);
+
+// Fixed size, lock free set of board hashes whose subtrees are known to
+// contain no solution.  A dead board stays dead no matter how the search
+// reached it, so one table can be shared by any number of searches and
+// threads.
+//
+// Each slot holds a full 64 bit hash and new entries overwrite old ones.
+// Two distinct boards would have to collide in all 64 bits for a live
+// subtree to be pruned.
+class TranspositionTable{
+public:
+    static const int kMaxLog2Entries = 26; // 512 MiB
+
+    // Holds 2^log2_entries hashes; log2_entries is clamped to 1 through
+    // kMaxLog2Entries.
+    explicit TranspositionTable(int log2_entries = 20);
+
+    // True if the board with this hash is known to be dead.
+    bool is_dead(ZobristHash hash);
+    void record_dead(ZobristHash hash);
+    void clear();
+
+    size_t size() const{ return entries_.size(); }
+    long long hits() const{ return hits_.load(std::memory_order_relaxed); }
+    long long misses() const{ return misses_.load(std::memory_order_relaxed); }
+    long long stores() const{ return stores_.load(std::memory_order_relaxed); }
+
+    void print_stats(std::ostream &os) const;
+
+protected:
+    static int clamp_log2_entries(int log2_entries);
+
+    std::vector<std::atomic<ZobristHash> > entries_;
+    ZobristHash mask_;
+    std::atomic<long long> hits_, misses_, stores_;
+
+private:
+    TranspositionTable(const TranspositionTable &);
+    TranspositionTable& operator=(const TranspositionTable &);
+};
+
+#endif // _TRANSPOSITION_TABLE_H_